@@ -0,0 +1,1131 @@
+/*
+ *  ddca.c
+ *  The deterministic DCA engine
+ *  Created by Julie Greensmith on 27/03/2008.
+ *	Modified by Feng Gu on 11/07/2008.
+ *	The function of calculating MCAV and Kalpha has been integrated.
+ *
+ *  Modified by Denis Pilipenko on 02/05/2013
+ *  Adapted for multiple data stream processing
+ *  Dual and Multiple Cooccurrence Analysis integrated
+ *
+ *  All the state lives in the engine structure, see ddca.h
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <math.h>
+#include <stdint.h>
+
+#include "ddca.h"
+
+#define FACTOR 100
+#define NUM_OUTPUT 3
+#define MAX_MIG 10000   /*original migration threshold */
+#define NUM_CELL 1001   /*original number of cells in population */
+#define SIG_BATCH 64    /*signal records weighted at once */
+
+#ifndef CO_SKETCH
+#define CO_SKETCH 0     /*cooccurrence mode: 0 - exact timestamps, 1 - time-slot sketch */
+#endif
+/*
+ *  An antigen seen in d distinct TIME_WIN_CO slots sets up to 2d bits of its sketch
+ *  (d + 1 for consecutive slots). Past about a quarter full the chance overlap grows
+ *  quickly and the estimates drop, so SKETCH_BITS should be at least 8 times the
+ *  number of distinct slots of the busiest antigen (about 2000 for 16384 bits, the
+ *  busiest antigen of the test data has 1265)
+ */
+#ifndef SKETCH_BITS
+#define SKETCH_BITS 16384   /*sketch size in bits, a multiple of 64 */
+#endif
+#if SKETCH_BITS <= 0 || SKETCH_BITS % 64 != 0
+#error "SKETCH_BITS must be a positive multiple of 64"
+#endif
+#define SKETCH_WORDS (SKETCH_BITS / 64)
+#ifndef SKETCH_Z
+#define SKETCH_Z 3.0    /*standard deviations above chance overlap to accept a cooccurrence */
+#endif
+
+#ifndef DC_COMPACT
+#define DC_COMPACT 0    /*working state layout: 0 - full precision, 1 - packed antigen counters and timestamps */
+#endif
+#define DC_SPILL 4      /*overflow entries per DC for saturated 16-bit antigen counters */
+#define TIME_UNIT 0.00001   /*resolution of the packed timestamp offsets (10 us) */
+
+#if DC_COMPACT
+typedef uint32_t agtime;    /*timestamp offset from timeEpoch in TIME_UNIT steps plus one, 0 - empty */
+#else
+typedef double agtime;  /*timestamp, 0 - empty */
+#endif
+
+struct DC
+{
+    float lifespan;	/*migration threshold countdown */
+    float k;	/*K value variable */
+    int agLo, agHi; /*range of the antigen IDs collected since the last log, empty if agLo > agHi */
+#if DC_COMPACT
+    uint16_t antigen[99999];    /*local antigen profile, saturates at 0xffff */
+    int spillAg[DC_SPILL];  /*overflow table of the saturated antigen counters */
+    int spillNum[DC_SPILL];
+#else
+    int antigen[99999]; /*local antigen profile */
+#endif
+    int iter; /*the number of iterations of signal updates received*/
+    int incarnations;
+    int id;
+    int totIter;
+    int totAg; /*the total amount of antigen a DC has collected per incarnation */
+};
+
+struct agsum
+{
+    float s,m,k;    /*semi-mature, mature and K totals of an antigen */
+};
+
+struct agtype
+{
+    float k,mcav;
+    int id;
+#if CO_SKETCH
+    uint64_t slots[SKETCH_WORDS];   /*hashed TIME_WIN_CO slots the antigen was seen in */
+#else
+    int timeNum;    /*timestamp index */
+    agtime t[200];  /*timestamp collection array */
+#endif
+    int antigens[20][2];    /*2D array for storing dual cooccurrences */
+    int ant_index;  /*cooccurrence index */
+};
+
+struct ddca_engine
+{
+    struct DC *cell[DDCA_NUM_STREAM];    /*DC populations (1-4) */
+    unsigned int cell_index[DDCA_NUM_STREAM];    /*for the selection of DCs per antigen */
+    int numStreams;
+
+    unsigned int numCells;   /*DC population size */
+    float maxMig;    /*migration threshold */
+    double timeEpoch;    /*earliest timestamp of the run */
+    double timeWinSave;  /* time window for saving timestamps*/
+    double timeWinCo;  /* time window for checking the cooccurrence*/
+    unsigned long lostAntigens; /*antigen counts that did not fit the compact layout */
+    unsigned long lostTimestamps;   /*timestamps outside the range of the compact layout */
+    int saturated;  /*dangerous antigens with a sketch past the accuracy limit at the last poll */
+    int numInput;   /*number of signals in a signal record */
+    float csmWeight[DDCA_MAX_INPUT];    /*per-signal weights of the CSM value */
+    float kWeight[DDCA_MAX_INPUT];  /*per-signal weights of the K value */
+    int randomised; /*random antigen assignment and lifespans */
+    uint64_t state; /*random generator state */
+
+    struct agsum *sums; /*global antigen profile */
+    struct agtype *agsG;    /*timestamps of the global antigen profile, NULL - profile only */
+    struct agtype agsD[DDCA_MAX_DANGER];    /*dangerous antigen profile */
+    unsigned int ags_index;  /*index for dangerous antigen profile */
+    int numDangerous;   /*dangerous antigens found, including the ones not kept */
+
+    /*array for storing multiple cooccurrences, a dangerous antigen is recorded in one
+      group at most and the last column always ends a group */
+    int cooccurrenceTemp[DDCA_MAX_DANGER][DDCA_MAX_DANGER + 1];
+    int groupLen[DDCA_MAX_DANGER];  /*number of antigens per multiple cooccurrence */
+    int tempIndex1;
+    int tempIndex2;
+
+    struct ddca_antigen *profile;   /*results of the last poll */
+    int numProfile;
+    struct ddca_antigen dangerous[DDCA_MAX_DANGER];
+    struct ddca_pair pairs[DDCA_MAX_DANGER * 20];
+    int numPairs;
+};
+
+static const float defCsmWeight[2] = {1, 1};   /*default weights of the danger and safe signals */
+static const float defKWeight[2] = {1, -2};
+
+static void cooccurrenceRec(struct ddca_engine *e, int aId);
+
+/*
+ *  *state - generator state;
+ *  A function that returns the next number of a seeded pseudo-random sequence (splitmix64).
+ *  Unlike rand() it keeps no hidden state, so engines can draw concurrently
+ */
+static uint64_t next_rand(uint64_t *state)
+{
+    uint64_t z;
+    z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/*
+ *  e - engine;
+ *  A function that returns a random migration threshold between 0 and maxMig
+ */
+static float rand_lifespan(struct ddca_engine *e)
+{
+    return (float) ((next_rand(&e->state) >> 11) * (1.0 / 9007199254740992.0) * e->maxMig);
+}
+
+/*
+ *  dc - the DC structure; ag - antigen id;
+ *  A function that counts the antigen in the local profile of the DC.
+ *  Returns -1 if the counter and the overflow table of the DC are full
+ */
+static int add_antigen(struct DC *dc, int ag)
+{
+#if DC_COMPACT
+    int i;
+#endif
+    if (ag < dc->agLo)
+        dc->agLo = ag;
+    if (ag > dc->agHi)
+        dc->agHi = ag;
+#if DC_COMPACT
+    if (dc->antigen[ag] < 0xffff)
+    {
+        dc->antigen[ag]++;
+        return 0;
+    }
+    for(i=0; i< DC_SPILL; i++)
+    {   // the counter is saturated, keep counting in the overflow table
+        if (dc->spillNum[i] == 0 || dc->spillAg[i] == ag)
+        {
+            dc->spillAg[i] = ag;
+            dc->spillNum[i]++;
+            return 0;
+        }
+    }
+    return -1;
+#else
+    dc->antigen[ag]++;
+    return 0;
+#endif
+}
+
+/*
+ *  dc - the DC structure; ag - antigen id;
+ *  A function that returns the count of the antigen in the local profile and resets it
+ */
+static int take_antigen(struct DC *dc, int ag)
+{
+    int n;
+#if DC_COMPACT
+    int i;
+#endif
+    n = dc->antigen[ag];
+#if DC_COMPACT
+    if (n == 0xffff)
+    {
+        for(i=0; i< DC_SPILL; i++)
+        {
+            if (dc->spillNum[i] && dc->spillAg[i] == ag)
+            {
+                n += dc->spillNum[i];
+                dc->spillNum[i] = 0;
+            }
+        }
+    }
+#endif
+    dc->antigen[ag] = 0;
+    return n;
+}
+
+#if !CO_SKETCH
+/*
+ *  e - engine; time - timestamp;
+ *  A function that converts a timestamp into the stored timestamp format.
+ *  Returns 0 if the timestamp is out of the range of the compact layout
+ */
+static agtime to_agtime(const struct ddca_engine *e, double time)
+{
+#if DC_COMPACT
+    double off;
+    off = (time - e->timeEpoch) / TIME_UNIT + 1.5;
+    if (off < 1 || off >= 4294967296.0)
+        return 0;
+    return (agtime) off;
+#else
+    return time;
+#endif
+}
+
+/*
+ *  a, b - stored timestamps;
+ *  A function that returns the distance between two stored timestamps in seconds
+ */
+static double time_gap(agtime a, agtime b)
+{
+#if DC_COMPACT
+    return (a > b ? a - b : b - a) * TIME_UNIT;
+#else
+    return fabs(a - b);
+#endif
+}
+#endif
+
+/*
+ *  e - engine; dc - the DC structure; cell - DC population;
+ *  A function that initialises a DC in the population
+ */
+static void initDC(struct ddca_engine *e, struct DC *dc, struct DC *cell)
+{
+    float tm_interval;
+    tm_interval = e->maxMig / (e->numCells-1);
+    dc->id = dc - cell;
+    if (e->randomised)
+        dc->lifespan = rand_lifespan(e);
+    else
+        dc->lifespan = ((dc) - cell) * tm_interval;
+    dc->iter = 0;
+    dc->totIter = 0;
+    dc->incarnations = 0;
+    dc->totAg = 0;
+    dc->agLo = 99999;
+    dc->agHi = -1;
+}
+
+/*
+ *  str - input; split - separator; toks - array of input elements;
+ *  max_toks - maximum number of elements;
+ *  A function that parses a single data input
+ */
+static int easy_explode(char *str, char split, char **toks, int max_toks)
+{
+    char *tmp;
+    int tok;
+    int state;
+
+    for(tmp=str,state=tok=0; *tmp && tok < max_toks; tmp++)
+    {
+        if ( state == 0 )
+        {
+            if ( *tmp == split )
+            {
+                toks[tok++] = NULL;
+            }
+            else if ( !isspace(*tmp) )
+            {
+                state = 1;
+                toks[tok++] = tmp;
+            }
+        }
+        else if ( state == 1 )
+        {
+            if ( *tmp == split || isspace(*tmp) )
+            {
+                *tmp = '\0';
+                state = 0;
+            }
+        }
+    }
+
+    return tok;
+}
+
+#if CO_SKETCH
+/*
+ *  slot - time slot number;
+ *  A function that maps a time slot onto a bit of the antigen sketch
+ */
+static unsigned int sketch_bit(long long slot)
+{
+    uint64_t h = (uint64_t) slot;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return (unsigned int) (h % SKETCH_BITS);
+}
+
+/*
+ *  e - engine; ag - antigen profile entry; time - timestamp;
+ *  A function that records the timestamp in the antigen sketch. The slot after the
+ *  current one is marked as well, so two timestamps that are at most TIME_WIN_CO
+ *  apart always share a bit
+ */
+static void sketch_add(const struct ddca_engine *e, struct agtype *ag, double time)
+{
+    long long slot;
+    unsigned int b;
+    slot = (long long) floor(time / e->timeWinCo);
+    b = sketch_bit(slot);
+    ag->slots[b / 64] |= (uint64_t) 1 << (b % 64);
+    b = sketch_bit(slot + 1);
+    ag->slots[b / 64] |= (uint64_t) 1 << (b % 64);
+}
+
+/*
+ *  x - sketch word;
+ *  A function that counts the set bits of a sketch word
+ */
+static int popcount64(uint64_t x)
+{
+#if defined(__GNUC__)
+    return __builtin_popcountll(x);
+#else
+    int n = 0;
+    while (x)
+    {
+        x &= x - 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+/*
+ *  ag - antigen profile entry;
+ *  A function that returns the number of set bits of the antigen sketch
+ */
+static int sketch_fill(const struct agtype *ag)
+{
+    int w;
+    int n = 0;
+    for(w=0; w < SKETCH_WORDS; w++)
+    {
+        n += popcount64(ag->slots[w]);
+    }
+    return n;
+}
+
+/*
+ *  a, b - antigen profile entries;
+ *  A function that estimates the number of shared time slots of two antigens.
+ *  The overlap expected from hash collisions alone is subtracted and the estimate
+ *  is only accepted if it lies SKETCH_Z standard deviations above that level
+ */
+static int sketch_cooccurrence(const struct agtype *a, const struct agtype *b)
+{
+    int w;
+    int na = 0, nb = 0, nab = 0;
+    double chance;
+    for(w=0; w < SKETCH_WORDS; w++)
+    {
+        na += popcount64(a->slots[w]);
+        nb += popcount64(b->slots[w]);
+        nab += popcount64(a->slots[w] & b->slots[w]);
+    }
+    chance = (double) na * nb / SKETCH_BITS;
+    if (nab - chance <= SKETCH_Z * sqrt(chance))
+        return 0;
+    return (int) (nab - chance + 0.5);
+}
+#endif
+
+/*
+ *  e - engine; ag - antigen id; dc - DC structure; time - timestamp; ags - antigen profile
+ *  A function that processes the antigen for a given DC and saves the timestamp
+ */
+static void do_antigen(struct ddca_engine *e, int ag, struct DC *dc, double time, struct agtype *ags)
+{
+#if !CO_SKETCH
+    agtime t;
+#endif
+    if (add_antigen(dc, ag))
+        e->lostAntigens++;
+    if (ags == NULL)    // profile only, no cooccurrence analysis
+        return;
+#if CO_SKETCH
+    sketch_add(e, &ags[ag], time);
+#else
+    t = to_agtime(e, time);
+#if DC_COMPACT
+    if (!t)
+    {   // not stored rather than clamped, it would match all other clamped timestamps
+        e->lostTimestamps++;
+        return;
+    }
+#endif
+    if (ags[ag].timeNum >= 0 && ags[ag].timeNum < 200)
+    {   // checks that the current timestamp is not within a specified time window,
+        // an empty slot is always filled whatever the stored timestamp encoding
+        if(ags[ag].timeNum == 0 || !ags[ag].t[ags[ag].timeNum] ||
+           time_gap(ags[ag].t[ags[ag].timeNum], ags[ag].t[ags[ag].timeNum - 1]) >= e->timeWinSave)
+        {
+            ags[ag].t[ags[ag].timeNum] = t;
+            ags[ag].timeNum++;
+            if (ags[ag].timeNum == 200)
+                ags[ag].timeNum = 0;
+        }
+    }
+    if (!ags[ag].timeNum)
+    {
+        ags[ag].t[0] = t;
+        ags[ag].timeNum = 1;
+    }
+#endif
+}
+
+/*
+ *  dc - DC structure; ags - antigen profile
+ *  A function that updates the global antigen profile by a given DC
+ */
+static void log_antigen(struct DC *dc, struct agsum *ags)
+{
+    int q;
+    int yy;
+    int n;
+
+    for(q = dc->agLo; q <= dc->agHi; q++)
+    {   // only the range of the collected antigens, most DCs hold a few or none
+        if(dc->antigen[q])
+        {
+            n = take_antigen(dc, q);
+            dc->totAg += n;
+            for(yy= 0; yy < n; yy++)
+            {
+                ags[q].k = ags[q].k + dc->k;
+                if(dc->k > 0)
+                {
+                    ags[q].m = ags[q].m + 1;    // update m if mature cell (danger)
+                }
+                else
+                {
+                    ags[q].s = ags[q].s + 1;    // update s if semi-mature cell (safe)
+                }
+            }
+        }
+    }
+    dc->agLo = 99999;
+    dc->agHi = -1;
+    //printf("DC_id: %d, totAg: %d , iter: %d \n", dc->id, dc->totAg, dc->iter);
+}
+
+/*
+ *  e - engine; K - K value; csm - CSM value; dc - DC structure; cell - DC population;
+ *  A function that updates the DC based on the signal's K and CSM values
+ */
+static void update_DC(struct ddca_engine *e, float K, float csm, struct DC *dc, struct DC *cell)
+{
+    int tr_interval;
+    /* update DC output signals */
+    dc->lifespan -= csm;
+    dc->k += K;
+    dc->iter++;
+
+    if (dc->lifespan <= 0)  // cell reincarnation if lifespan has reached zero
+    {
+        log_antigen(dc, e->sums);
+        if (e->randomised)
+        {
+            dc->lifespan = rand_lifespan(e);
+        }
+        else
+        {
+            tr_interval = (float) MAX_MIG / (e->numCells - 1);
+            dc->lifespan = ((dc) - cell) * tr_interval;
+        }
+        dc->k = 0;
+        dc->totIter += dc->iter;
+        //printf("running totIter %d", dc->totIter);
+        //printf("reset DC lifespan is %f \n", dc->lifespan);
+        dc->iter = 0;
+        dc->totAg = 0;
+        dc->incarnations++;
+    }
+    /* pass antigen to the global antigen profile */
+
+}
+
+/*
+ *  e - engine; rec - signal records; num - number of records; csm, k - output values;
+ *  A function that weights the signals of a run of signal records into their CSM and
+ *  K values. The common 2-signal layout is evaluated without the inner loop
+ */
+static void signal_values(const struct ddca_engine *e, const struct ddca_record *rec, int num,
+                          float *csm, float *k)
+{
+    int r,j;
+
+    if (e->numInput == 2)
+    {
+        const float c0 = e->csmWeight[0], c1 = e->csmWeight[1];
+        const float k0 = e->kWeight[0], k1 = e->kWeight[1];
+        for(r=0; r< num; r++)
+        {
+            csm[r] = c0 * rec[r].sig[0] + c1 * rec[r].sig[1];
+            k[r] = k0 * rec[r].sig[0] + k1 * rec[r].sig[1];
+        }
+        return;
+    }
+    for(r=0; r< num; r++)
+    {
+        csm[r] = 0;
+        k[r] = 0;
+        for(j=0; j< e->numInput; j++)
+        {   // weighted sum of the signals
+            csm[r] += e->csmWeight[j] * rec[r].sig[j];
+            k[r] += e->kWeight[j] * rec[r].sig[j];
+        }
+    }
+}
+
+/*
+ *  e - engine; csm, k - CSM and K values of a signal record; cell - DC population;
+ *  A function that passes the signal values to all the DCs of the population
+ */
+static void do_signals(struct ddca_engine *e, float csm, float k, struct DC *cell)
+{
+    unsigned int j;
+
+    //printf("signal: csm=%f k=%f\n", csm, k);
+
+    for(j=0; j< e->numCells; j++)
+    {
+        update_DC(e, k, csm, &cell[j], cell);
+    }
+
+}
+
+/*
+ *  *buf - input buffer; numInput - signals per signal record; *rec - decoded record;
+ *  A function that decodes a data stream line into an antigen or signal record
+ */
+int ddca_parse_line(char *buf, int numInput, struct ddca_record *rec)
+{
+    char *tok[DDCA_MAX_INPUT + 2];
+    int n,p;
+    char *sp = " "; // this is the separation between attributes
+
+    if (numInput < 1 || numInput > DDCA_MAX_INPUT)
+        return DDCA_ERR_INPUT;
+    n = easy_explode(buf, *sp, tok, numInput + 2);
+
+    if (n == 3 && tok[1] && !strcmp(tok[1], "antigen"))
+    {   /*this is antigen that has 3 fields*/
+        rec->ag = atoi(tok[2]);  // antigen ID
+        rec->time = strtod(tok[0], NULL);    // timestamp
+        if (rec->ag >= 0 && rec->ag < 99999)
+            return DDCA_OK;
+    }
+    else if (n == numInput + 2 && tok[1] && !strcmp(tok[1], "signal"))
+    {   /*this is for signals that have numInput + 2 fields */
+        rec->ag = -1;
+        rec->time = tok[0] ? strtod(tok[0], NULL) : 0;
+        for(p=0; p< numInput; p++)
+        {
+            rec->sig[p] = tok[p + 2] ? atof(tok[p + 2]) : 0;    // danger, safe, ... signals
+        }
+        return DDCA_OK;
+    }
+    if (n == 3)
+        return DDCA_ERR_ANTIGEN;
+    else if (n == numInput + 2)
+        return DDCA_ERR_SIGNAL;
+    return DDCA_ERR_INPUT;
+}
+
+/*
+ *  config - engine parameters;
+ *  A function that checks the engine parameters
+ */
+int ddca_check_config(const struct ddca_config *config)
+{
+    if (config->recordSize != sizeof(struct ddca_record) ||
+        config->numInput < 1 || config->numInput > DDCA_MAX_INPUT ||
+        (config->numInput != 2 && (config->csmWeights == NULL || config->kWeights == NULL)) ||
+        config->numCells < 2 || config->maxMig <= 0 ||
+        config->numStreams < 1 || config->numStreams > DDCA_NUM_STREAM ||
+        !(config->timeWinSave > 0) || !(config->timeWinCo > 0))
+        return DDCA_ERR_CONFIG;
+#if DC_COMPACT
+    if (!config->hasEpoch || !isfinite(config->epoch))  // the packed timestamps are offsets from the epoch
+        return DDCA_ERR_EPOCH;
+#endif
+    return DDCA_OK;
+}
+
+/*
+ *  config - engine parameters;
+ *  A function that creates an engine and initialises its DC populations
+ */
+ddca_engine *ddca_create(const struct ddca_config *config)
+{
+    struct ddca_engine *e;
+    unsigned int i;
+    int s;
+
+    if (ddca_check_config(config) != DDCA_OK)
+        return NULL;
+    e = calloc(1, sizeof(struct ddca_engine));
+    if (e == NULL)
+        return NULL;
+    e->numCells = config->numCells;
+    e->maxMig = config->maxMig;
+    e->numStreams = config->numStreams;
+    e->timeWinSave = config->timeWinSave;
+    e->timeWinCo = config->timeWinCo;
+    e->timeEpoch = config->epoch;
+    e->numInput = config->numInput;
+    for(s=0; s < e->numInput; s++)
+    {
+        e->csmWeight[s] = config->csmWeights ? config->csmWeights[s] : defCsmWeight[s];
+        e->kWeight[s] = config->kWeights ? config->kWeights[s] : defKWeight[s];
+    }
+    e->randomised = config->randomised;
+    e->state = config->seed;
+
+    e->sums = calloc(99999, sizeof(struct agsum));
+    if (!config->profileOnly)
+        e->agsG = calloc(99999, sizeof(struct agtype));
+    e->profile = calloc(99999, sizeof(struct ddca_antigen));
+    if (e->sums == NULL || (e->agsG == NULL && !config->profileOnly) || e->profile == NULL)
+    {
+        ddca_destroy(e);
+        return NULL;
+    }
+    for(s=0; s < e->numStreams; s++)
+    {
+        e->cell[s] = calloc(e->numCells, sizeof(struct DC));
+        if (e->cell[s] == NULL)
+        {
+            ddca_destroy(e);
+            return NULL;
+        }
+    }
+    // initialise the DCs in the populations
+    for(s=0; s < e->numStreams; s++)
+    {
+        for(i=0; i < e->numCells; i++)
+        {
+            initDC(e, &e->cell[s][i], e->cell[s]);
+        }
+    }
+    return e;
+}
+
+/*
+ *  e - engine;
+ *  A function that releases the engine
+ */
+void ddca_destroy(ddca_engine *e)
+{
+    int s;
+    if (e == NULL)
+        return;
+    for(s=0; s < DDCA_NUM_STREAM; s++)
+    {
+        free((void*) e->cell[s]);
+    }
+    free((void*) e->sums);
+    free((void*) e->agsG);
+    free((void*) e->profile);
+    free((void*) e);
+}
+
+/*
+ *  e - engine; stream - data stream; *rec - records; num - number of records;
+ *  A function that passes the records of a data stream to the antigen and signal processing
+ */
+int ddca_push(ddca_engine *e, int stream, const struct ddca_record *rec, size_t num)
+{
+    struct DC *cell;
+    unsigned int index;
+    size_t i;
+    int r,n;
+    float csm[SIG_BATCH], k[SIG_BATCH];
+
+    if (stream < 0 || stream >= e->numStreams || e->cell[stream] == NULL)
+        return DDCA_ERR_STREAM;
+    for(i=0; i< num; i++)
+    {   // check the whole batch, so it is processed either completely or not at all
+        if (rec[i].ag < -1 || rec[i].ag >= 99999)
+            return DDCA_ERR_ANTIGEN;
+    }
+    cell = e->cell[stream];
+    index = e->cell_index[stream];
+
+    for(i=0; i< num; i += n)
+    {
+        n = 1;
+        if (rec[i].ag >= 0)
+        {
+            if (e->randomised)
+            {   // antigens are passed to random DCs
+                index = next_rand(&e->state) % e->numCells;
+            }
+            else
+            {   // antigens are passed to the DCs in turn
+                index++;
+                index %= e->numCells;
+            }
+            do_antigen(e, rec[i].ag, &cell[index], rec[i].time, e->agsG);
+        }
+        else
+        {   // weight a run of signal records at once, then update the DCs in order
+            while (n < SIG_BATCH && i + n < num && rec[i + n].ag < 0)
+                n++;
+            signal_values(e, &rec[i], n, csm, k);
+            for(r=0; r< n; r++)
+            {
+                do_signals(e, csm[r], k[r], cell);
+            }
+        }
+    }
+    e->cell_index[stream] = index;
+    return DDCA_OK;
+}
+
+/*
+ *  e - engine; stream - data stream;
+ *  A function that updates the global antigen profile by the population of a finished
+ *  data stream and releases the population
+ */
+int ddca_end_stream(ddca_engine *e, int stream)
+{
+    unsigned int p;
+    if (stream < 0 || stream >= e->numStreams || e->cell[stream] == NULL)
+        return DDCA_ERR_STREAM;
+    for(p = 0; p < e->numCells; p++)
+    {
+        log_antigen(&e->cell[stream][p], e->sums);
+    }
+    free((void*) e->cell[stream]);
+    e->cell[stream] = NULL;
+    return DDCA_OK;
+}
+
+/*
+ *  e - engine;
+ *  A function that updates the global antigen profile by all the DCs
+ */
+void ddca_flush(ddca_engine *e)
+{
+    unsigned int p;
+    int s;
+    for(p = 0; p < e->numCells; p++)
+    {
+        //printf("flushed cell ID %d\n", p);
+        for(s=0; s < e->numStreams; s++)
+        {
+            if (e->cell[s])
+                log_antigen(&e->cell[s][p], e->sums);
+        }
+    }
+}
+
+/*
+ *  e - engine;
+ *  A function that calculates the MCAV and K values of the antigens
+ *  in the global profile and updates the 'dangerous' antigen profile
+ */
+static void result(struct ddca_engine *e)
+{
+    struct agsum *ags = e->sums;
+    int i;
+    float mcav,ka;
+    for(i=0; i<99999; i++)
+    {
+        if((ags[i].m + ags[i].s) != 0)
+        {
+            mcav = ags[i].m/(ags[i].m + ags[i].s);
+            ka = ags[i].k/(ags[i].m + ags[i].s);
+            e->profile[e->numProfile].id = i;
+            e->profile[e->numProfile].mcav = mcav;
+            e->profile[e->numProfile].k = ka;
+            e->numProfile++;
+            if (mcav > 0)
+                e->numDangerous++;
+            if (mcav > 0 && e->ags_index < DDCA_MAX_DANGER)
+            {
+                if (e->agsG)
+                    e->agsD[e->ags_index] = e->agsG[i];
+                e->agsD[e->ags_index].id = i;
+                e->agsD[e->ags_index].mcav = mcav;
+                e->agsD[e->ags_index].k = ka;
+                e->agsD[e->ags_index].ant_index = 0;
+                e->dangerous[e->ags_index].id = i;
+                e->dangerous[e->ags_index].mcav = mcav;
+                e->dangerous[e->ags_index].k = ka;
+                e->ags_index++;
+            }
+        }
+    }
+}
+
+/*
+ *  e - engine; id - antigen ID;
+ *  A function that checks if the given antigen has already been
+ *  recorded  in any of the cooccurrences
+ */
+static int checkCooccurrence(struct ddca_engine *e, int id)
+{
+    int k,l;
+    for(k=0; k<=e->tempIndex1; k++)
+    {
+        l = 0;
+        while(l < DDCA_MAX_DANGER && e->cooccurrenceTemp[k][l])
+        {
+            if(id == e->cooccurrenceTemp[k][l])
+                return k;
+            l++;
+        }
+    }
+    return -1;
+}
+
+/*
+ *  e - engine; id - antigen ID; dId - antigen ID;
+ *  A function that returns the ID for the cooccurrence recording
+ *  in the antigen's local 2D array
+ */
+static int checkAntigen(struct ddca_engine *e, int id, int dId)
+{
+    int j;
+    for(j=0; j< 20; j++)
+    {
+        if(id == e->agsD[dId].antigens[j][0])
+            return j;
+    }
+    return -1;
+}
+
+/*
+ *  e - engine; q - dangerous antigen index; id - antigen ID; n - number of matches;
+ *  A function that records n matches of the given antigen in the local 2D array
+ */
+static void addCooccurrence(struct ddca_engine *e, int q, int id, int n)
+{
+    struct agtype *agsD = e->agsD;
+    int aId;
+    aId = checkAntigen(e, id, q);
+    if (aId != -1)  // increment the number of matches
+        agsD[q].antigens[aId][1] = agsD[q].antigens[aId][1] + n;
+    else if (agsD[q].ant_index < 20)
+    {   // add a new entry if has not been previously recorded
+        agsD[q].antigens[agsD[q].ant_index][0] = id;
+        agsD[q].antigens[agsD[q].ant_index][1] = agsD[q].antigens[agsD[q].ant_index][1] + n;
+        agsD[q].ant_index = agsD[q].ant_index + 1;
+    }
+}
+
+/*
+ *  Dual Cooccurrence function
+ *  A function that compares the timestamps of dangerous antigens and records the matches
+ */
+static void cooccurrence(struct ddca_engine *e)
+{
+    struct agtype *agsD = e->agsD;
+    int q,i,j;
+#if CO_SKETCH
+    int n;
+    for(q=0; q < e->ags_index; q++)
+    {   // the estimates degrade once a sketch is more than a quarter full
+        if (sketch_fill(&agsD[q]) > SKETCH_BITS / 4)
+            e->saturated++;
+    }
+#else
+    int p,k;
+#endif
+    for(q =0; q < ((int) e->ags_index-1); q++)
+    {
+        memset(agsD[q].antigens, 0, sizeof(agsD[q].antigens[0][0]) * 20 * 2);
+        for(i = (q+1); i < e->ags_index; i++)
+        {
+#if CO_SKETCH
+            n = sketch_cooccurrence(&agsD[q], &agsD[i]);
+            if (n > 0)
+                addCooccurrence(e, q, agsD[i].id, n);
+#else
+            for(p=0; p< 200; p++)
+            {
+                for(k=0; k<200; k++)
+                {   // check that the antigens are within the same time window
+                    if (agsD[q].t[p] && agsD[i].t[k] && time_gap(agsD[q].t[p], agsD[i].t[k]) <= e->timeWinCo)
+                        addCooccurrence(e, q, agsD[i].id, 1);
+                }
+            }
+#endif
+        }
+    }
+    for(j=0; j<DDCA_MAX_DANGER; j++)    // collect the Dual cooccurrences
+    {
+        if(agsD[j].id)
+        {
+            for (i=0; i<20; i++)
+            {
+                if (agsD[j].antigens[i][1] != 0)
+                {
+                    e->pairs[e->numPairs].id1 = agsD[j].id;
+                    e->pairs[e->numPairs].id2 = agsD[j].antigens[i][0];
+                    e->pairs[e->numPairs].num = agsD[j].antigens[i][1];
+                    e->numPairs++;
+                }
+            }
+        }
+    }
+}
+
+/*
+ *  e - engine; id - antigen ID;
+ *  A function that adds the antigen to the current multiple cooccurrence.
+ *  Returns 0 if the group is full
+ */
+static int addGroup(struct ddca_engine *e, int id)
+{
+    if (e->tempIndex2 >= DDCA_MAX_DANGER)
+        return 0;
+    e->cooccurrenceTemp[e->tempIndex1][e->tempIndex2] = id;
+    e->tempIndex2++;
+    return 1;
+}
+
+/*
+ *  Multiple Cooccurrence Function
+ *  A function that groups the interconnected antigens into a string
+ */
+static void multiCooccurrence(struct ddca_engine *e)
+{
+    struct agtype *agsD = e->agsD;
+    int i,j;
+    e->tempIndex1 = 0;
+    for(j=0; j<DDCA_MAX_DANGER; j++)
+    {
+        if(agsD[j].id)
+        {
+            e->tempIndex2 = 0;
+            for (i=0; i<20; i++)
+            {
+                if (agsD[j].antigens[i][1] != 0 && checkCooccurrence(e, agsD[j].antigens[i][0]) == -1)
+                {
+                    if (checkCooccurrence(e, agsD[j].id) == -1)
+                        addGroup(e, agsD[j].id);   // add the first element of the string
+                    // add the cooccurred elements and start the recursive method with them
+                    if (addGroup(e, agsD[j].antigens[i][0]))
+                        cooccurrenceRec(e, agsD[j].antigens[i][0]);
+                }
+            }
+            if (e->tempIndex2 > 2 && e->tempIndex1 < DDCA_MAX_DANGER - 1)
+            {
+                e->groupLen[e->tempIndex1] = e->tempIndex2;
+                e->tempIndex1++;
+            }
+        }
+    }
+}
+
+/*
+ *  A recursive function that supplements the Multiple Cooccurrence function
+ */
+static void cooccurrenceRec(struct ddca_engine *e, int aId)
+{
+    struct agtype *agsD = e->agsD;
+    int i,j;
+    for (i=0; i<DDCA_MAX_DANGER; i++) {
+        if (agsD[i].id) {
+            for (j=0; j<20; j++)
+            {   // check if any other antigens have a cooccurrence with this ID
+                if (agsD[i].antigens[j][0] == aId && agsD[i].antigens[j][1] != 0 && checkCooccurrence(e, agsD[i].id) == -1)
+                    addGroup(e, agsD[i].id);
+            }
+        }
+        if (agsD[i].id == aId)
+        {
+            for (j=0; j<20; j++)
+            {   // check if this antigen ID has any other cooccurrences
+                if (agsD[i].antigens[j][1] != 0 && checkCooccurrence(e, agsD[i].antigens[j][0]) == -1 &&
+                    addGroup(e, agsD[i].antigens[j][0]))
+                    cooccurrenceRec(e, agsD[i].antigens[j][0]); // apply the same function on new cooccurrences
+            }
+        }
+    }
+}
+
+/*
+ *  e - engine;
+ *  A function that analyses the current antigen profile: MCAV and K values,
+ *  dangerous antigens, Dual and Multiple Cooccurrences
+ */
+int ddca_poll(ddca_engine *e)
+{
+    memset(e->agsD, 0, sizeof(e->agsD));
+    memset(e->cooccurrenceTemp, 0, sizeof(e->cooccurrenceTemp));
+    e->ags_index = 0;
+    e->numDangerous = 0;
+    e->numProfile = 0;
+    e->numPairs = 0;
+    e->saturated = 0;
+    e->tempIndex1 = 0;
+    e->tempIndex2 = 0;
+
+    result(e);
+    if (e->ags_index > 0 && e->agsG)
+    {
+        cooccurrence(e);  // Dual Cooccurrence
+        multiCooccurrence(e); // Multiple Cooccurrence
+    }
+    return e->numDangerous;
+}
+
+const struct ddca_antigen *ddca_profile(const ddca_engine *e, int *num)
+{
+    *num = e->numProfile;
+    return e->profile;
+}
+
+const struct ddca_antigen *ddca_dangerous(const ddca_engine *e, int *num)
+{
+    *num = e->ags_index;
+    return e->dangerous;
+}
+
+const struct ddca_pair *ddca_pairs(const ddca_engine *e, int *num)
+{
+    *num = e->numPairs;
+    return e->pairs;
+}
+
+int ddca_num_groups(const ddca_engine *e)
+{
+    return e->tempIndex1;
+}
+
+const int *ddca_group(const ddca_engine *e, int group, int *num)
+{
+    if (group < 0 || group >= e->tempIndex1)
+    {
+        *num = 0;
+        return NULL;
+    }
+    *num = e->groupLen[group];
+    return e->cooccurrenceTemp[group];
+}
+
+/*
+ *  e - engine; stream - data stream; index - DC index; stats - output;
+ *  A function that returns the statistics of a DC
+ */
+int ddca_dc_stats(const ddca_engine *e, int stream, unsigned int index, struct ddca_dc_stats *stats)
+{
+    const struct DC *dc;
+    if (stream < 0 || stream >= e->numStreams || e->cell[stream] == NULL || index >= e->numCells)
+        return DDCA_ERR_STREAM;
+    dc = &e->cell[stream][index];
+    stats->id = dc->id;
+    stats->lifespan = dc->lifespan;
+    stats->k = dc->k;
+    stats->iter = dc->iter;
+    stats->incarnations = dc->incarnations;
+    stats->totIter = dc->totIter;
+    return DDCA_OK;
+}
+
+/*
+ *  e - engine; antigens, timestamps - output;
+ *  A function that returns how many antigen counts and timestamps were lost
+ *  because they did not fit the compact layout
+ */
+void ddca_overflow(const ddca_engine *e, unsigned long *antigens, unsigned long *timestamps)
+{
+    *antigens = e->lostAntigens;
+    *timestamps = e->lostTimestamps;
+}
+
+/*
+ *  e - engine;
+ *  A function that returns the number of dangerous antigens whose cooccurrence
+ *  sketch was more than a quarter full at the last poll
+ */
+int ddca_saturated(const ddca_engine *e)
+{
+    return e->saturated;
+}
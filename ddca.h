@@ -0,0 +1,148 @@
+/*
+ *  ddca.h
+ *  The deterministic DCA engine
+ *
+ *  A reentrant DDCA engine with a C interface. Every engine keeps its own DC
+ *  populations and antigen profiles, so several engines can run in one process.
+ *  Records are pushed in batches per data stream and the antigen profile and
+ *  cooccurrences can be polled at any time.
+ */
+
+#ifndef DDCA_H
+#define DDCA_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef DDCA_MAX_INPUT
+#define DDCA_MAX_INPUT 4    /*maximum number of signals in a signal record */
+#endif
+#define DDCA_NUM_STREAM 4   /*maximum number of data streams of an engine */
+#define DDCA_TIME_WIN_SAVE 0.001    /*default time window for saving timestamps*/
+#define DDCA_TIME_WIN_CO 0.01   /*default time window for checking cooccurrence*/
+#define DDCA_MAX_DANGER 100 /*maximum number of dangerous antigens kept by a poll */
+
+/* return codes */
+#define DDCA_OK 0
+#define DDCA_ERR_INPUT -1   /*wrong input */
+#define DDCA_ERR_ANTIGEN -2 /*wrong antigen input */
+#define DDCA_ERR_SIGNAL -3  /*wrong signal input */
+#define DDCA_ERR_STREAM -4  /*no such data stream */
+#define DDCA_ERR_CONFIG -5  /*invalid engine configuration */
+#define DDCA_ERR_EPOCH -6   /*no finite epoch for the compact layout */
+
+typedef struct ddca_engine ddca_engine;
+
+struct ddca_config
+{
+    size_t recordSize;  /*sizeof(struct ddca_record) the caller was built with, must match the library */
+    int numInput;   /*number of signals in a signal record, 1 - DDCA_MAX_INPUT */
+    const float *csmWeights;    /*numInput per-signal weights of the CSM value, NULL - {1, 1} for 2 signals */
+    const float *kWeights;  /*numInput per-signal weights of the K value, NULL - {1, -2} for 2 signals */
+    unsigned int numCells;  /*DC population size */
+    float maxMig;   /*migration threshold */
+    int numStreams; /*number of data streams (DC populations), 1 - DDCA_NUM_STREAM */
+    double timeWinSave; /*time window for saving timestamps, > 0 */
+    double timeWinCo;   /*time window for checking the cooccurrence, > 0 */
+    int hasEpoch;   /*1 - epoch is set, required for the compact layout */
+    double epoch;   /*earliest timestamp of all streams */
+    int randomised; /*0 - round-robin antigens and lifespan ladder, 1 - random ones */
+    unsigned long seed; /*seed of the random antigen assignment and lifespans */
+    int profileOnly;    /*1 - MCAV and K values only: no timestamps are kept and ddca_poll
+                          finds no cooccurrences */
+};
+
+struct ddca_record
+{
+    double time;    /*timestamp */
+    int ag;     /*antigen ID (0 - 99998), -1 for a signal record */
+    float sig[DDCA_MAX_INPUT];   /*signal values (danger, safe, ...), numInput of them are used */
+};
+
+struct ddca_antigen
+{
+    int id;
+    float mcav;
+    float k;    /*K alpha */
+};
+
+struct ddca_pair
+{
+    int id1, id2;   /*cooccurring antigens */
+    int num;    /*number of matches */
+};
+
+struct ddca_dc_stats
+{
+    int id;
+    float lifespan;
+    float k;
+    int iter;
+    int incarnations;
+    int totIter;
+};
+
+/*
+ *  Engine life cycle. ddca_check_config returns DDCA_ERR_EPOCH if the compact layout
+ *  has no finite epoch and DDCA_ERR_CONFIG for the other invalid configurations
+ *  (including a recordSize other than the library's). ddca_create returns NULL if the
+ *  configuration is invalid or the populations cannot be allocated. The weights are
+ *  copied, so engines with different signal layouts can run side by side
+ */
+int ddca_check_config(const struct ddca_config *config);
+ddca_engine *ddca_create(const struct ddca_config *config);
+void ddca_destroy(ddca_engine *e);
+
+/*
+ *  Record input. ddca_parse_line decodes a data stream line with numInput signals
+ *  per signal record (the line is modified).
+ *  ddca_push processes num records of a data stream in place, without copying them.
+ *  The batch is checked first: if any antigen ID is out of range, no record is
+ *  processed and DDCA_ERR_ANTIGEN is returned.
+ *  ddca_end_stream passes the antigens of a finished stream to the antigen profile
+ *  and releases its population; ddca_flush does the same for all populations
+ *  but keeps them for ddca_dc_stats
+ */
+int ddca_parse_line(char *buf, int numInput, struct ddca_record *rec);
+int ddca_push(ddca_engine *e, int stream, const struct ddca_record *rec, size_t num);
+int ddca_end_stream(ddca_engine *e, int stream);
+void ddca_flush(ddca_engine *e);
+
+/*
+ *  Results. ddca_poll analyses the current antigen profile and returns the number
+ *  of dangerous antigens. Only the first DDCA_MAX_DANGER of them are kept for
+ *  ddca_dangerous and the cooccurrence analysis, a larger return value means the
+ *  rest were dropped. The other functions return the results of the last poll
+ *  and stay valid until the next one
+ */
+int ddca_poll(ddca_engine *e);
+const struct ddca_antigen *ddca_profile(const ddca_engine *e, int *num);
+const struct ddca_antigen *ddca_dangerous(const ddca_engine *e, int *num);
+const struct ddca_pair *ddca_pairs(const ddca_engine *e, int *num);
+int ddca_num_groups(const ddca_engine *e);
+const int *ddca_group(const ddca_engine *e, int group, int *num);
+int ddca_dc_stats(const ddca_engine *e, int stream, unsigned int index, struct ddca_dc_stats *stats);
+
+/*
+ *  Overflow of the compact layout (-DDC_COMPACT=1): antigen counts dropped because
+ *  a DC ran out of overflow entries, and timestamps not stored because they lie
+ *  before the epoch or about 11.9 hours after it. Always zero in the full layout
+ */
+void ddca_overflow(const ddca_engine *e, unsigned long *antigens, unsigned long *timestamps);
+
+/*
+ *  Accuracy of the cooccurrence sketch (-DCO_SKETCH=1): the number of dangerous
+ *  antigens whose sketch was more than a quarter full at the last poll. Their
+ *  cooccurrences are underestimated or missed, a larger SKETCH_BITS is needed.
+ *  Always zero with the stored timestamps
+ */
+int ddca_saturated(const ddca_engine *e);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
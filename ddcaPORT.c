@@ -9,99 +9,48 @@
  *  Adapted for multiple data stream processing
  *  Dual and Multiple Cooccurrence Analysis integrated
  *  DDCA for the analysis of port scan data
+ *
+ *  The command line front end of the DDCA engine (ddca.c)
  */
 
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
-#include <ctype.h>
-#include <math.h>
 #include <time.h>
 
-#define FACTOR 100
-#define NUM_INPUT 2
-#define NUM_OUTPUT 3
-#define MAX_MIG 10000   /*original migration threshold */
-#define NUM_CELL 1001   /*original number of cells in population */
-#define TIME_WIN_SAVE 0.001 /*time window for saving timestamps*/
-#define TIME_WIN_CO 0.01  /*time window for checking cooccurrence*/
-
-
-void cooccurrenceRec(int aId);
-
-struct DC
-{
-    float lifespan;	/*migration threshold countdown */
-    float k;	/*K value variable */
-    int antigen[99999]; /*local antigen profile */
-    int iter; /*the number of iterations of signal updates received*/
-    int incarnations;
-    int id;
-    int totIter;
-    int totAg; /*the total amount of antigen a DC has collected per incarnation */
-};
-
-struct agtype
-{
-    float s,m,k,mcav;
-    int id;
-    int timeNum;    /*timestamp index */
-    double t[200];  /*timestamp collection array */
-    int antigens[20][2];    /*2D array for storing dual cooccurrences */
-    int ant_index;  /*cooccurrence index */
-};
-
-/* DC populations initialisation (1-4) */
-static struct DC *cell1;
-static struct DC *cell2;
-static struct DC *cell3;
-static struct DC *cell4;
-
-static unsigned int numCells;   /*DC population size */
-static float maxMig;    /*migration threshold */
-
-static double timeWinSave;  /* time window for saving timestamps*/
-static double timeWinCo;  /* time window for checking the cooccurrence*/
-
-static unsigned int cell_index1;
-static unsigned int cell_index2;
-static unsigned int cell_index3;
-static unsigned int cell_index4;
-static unsigned int ags_index;  /*index for dangerous antigen profile */
-
-int cooccurrenceTemp[100][50];   /*array for storing multiple cooccurrences */
-int tempIndex1;
-int tempIndex2;
+#include "ddca.h"
+
+#ifndef NUM_INPUT
+#define NUM_INPUT 2     /*number of signals in a signal record of the logs */
+#elif NUM_INPUT != 2 && (!defined(CSM_WEIGHTS) || !defined(K_WEIGHTS))
+#error "CSM_WEIGHTS and K_WEIGHTS must be given when NUM_INPUT is not 2"
+#endif
+#if NUM_INPUT > DDCA_MAX_INPUT
+#error "NUM_INPUT must not exceed DDCA_MAX_INPUT"
+#endif
+#ifndef CSM_WEIGHTS
+#define CSM_WEIGHTS {1, 1}  /*per-signal weights of the CSM value (danger, safe) */
+#endif
+#ifndef K_WEIGHTS
+#define K_WEIGHTS {1, -2}   /*per-signal weights of the K value (danger, safe) */
+#endif
+#ifndef ENSEMBLE
+#define ENSEMBLE 1      /*number of randomly seeded DC populations run alongside; 1 - single run */
+#endif
+#ifndef ENSEMBLE_SEED
+#define ENSEMBLE_SEED 1 /*seed of the first ensemble population */
+#endif
 
 char text[20];  /*buffer for user input */
 
-static struct agtype agsG[99999];   /*global antigen profile */
-
-static struct agtype agsD[100];     /*dangerous antigen profile */
+static const float csmWeight[NUM_INPUT] = CSM_WEIGHTS;
+static const float kWeight[NUM_INPUT] = K_WEIGHTS;
 
 /*
- *  dc - the DC structure; numCells - size of the population;
- *  cell - DC population;
- *  A function that initialises a DC in the population
- */
-static void initDC(struct DC *dc, int numCells, struct DC *cell)
-{
-    float tm_interval;
-    tm_interval = maxMig / (numCells-1);
-    dc->id = dc - cell;
-    dc->lifespan = ((dc) - cell) * tm_interval;
-    printf("lifespan = %f, tm_interval =%f\n", dc->lifespan, tm_interval);
-    dc->iter = 0;
-    dc->totIter = 0;
-    dc->incarnations = 0;
-    dc->totAg = 0;
-}
-
-/*
- *  dc - the DC structure;
+ *  stats - the DC statistics;
  *  A function that displays the DC statistics
  */
-static void dc_stats(struct DC *dc)
+static void dc_stats(const struct ddca_dc_stats *dc)
 {
     float iterIncarn;
     if(dc->incarnations > 0)
@@ -116,391 +65,167 @@ static void dc_stats(struct DC *dc)
 }
 
 /*
- *  str - input; split - separator; toks - array of input elements;
- *  max_toks - maximum number of elements;
- *  A function that parses a single data input
+ *  *file - data log; **rec - decoded records;
+ *  A function that reads a data log into an array of records and returns their number
  */
-static int easy_explode(char *str, char split, char **toks, int max_toks)
+static int read_log(FILE *file, struct ddca_record **rec)
 {
-    char *tmp;
-    int tok;
-    int state;
+    char buf[256];
+    int num = 0;
+    int size = 0;
+    int err;
 
-    for(tmp=str,state=tok=0; *tmp && tok < max_toks; tmp++)
+    *rec = NULL;
+    if (file == NULL)
     {
-        if ( state == 0 )
+        fprintf(stderr, "Error: cannot open the log\n");
+        getchar();
+        exit(EXIT_FAILURE);
+    }
+    while (fgets (buf, sizeof(buf), file) != NULL ) /* read a line */
+    {
+        char *tmp;
+        tmp = strchr(buf, '\n');
+        if(tmp)
         {
-            if ( *tmp == split )
-            {
-                toks[tok++] = NULL;
-            }
-            else if ( !isspace(*tmp) )
-            {
-                state = 1;
-                toks[tok++] = tmp;
-            }
+            *tmp = 0;
         }
-        else if ( state == 1 )
+        if (num == size)
         {
-            if ( *tmp == split || isspace(*tmp) )
+            size = size ? size * 2 : 1024;
+            *rec = realloc(*rec, size * sizeof(struct ddca_record));
+            if (*rec == NULL)
             {
-                *tmp = '\0';
-                state = 0;
+                fprintf(stderr, "Error in record allocation\n");
+                exit(EXIT_FAILURE);
             }
         }
-    }
-
-    return tok;
-}
-
-/*
- *  ag - antigen id; dc - DC structure; time - timestamp; ags - antigen profile
- *  A function that processes the antigen for a given DC and saves the timestamp
- */
-static void do_antigen(pid_t ag, struct DC *dc, double time, struct agtype *ags)
-{
-    dc->antigen[ag]++;
-    if (ags[ag].timeNum >= 0 && ags[ag].timeNum < 200)
-    {   // checks that the current timestamp is not within a specified time window
-        if(ags[ag].timeNum == 0 || (ags[ag].timeNum > 0 &&
-                                    fabs(ags[ag].t[ags[ag].timeNum] - (ags[ag].t[ags[ag].timeNum - 1])) >= timeWinSave))
+        err = ddca_parse_line(buf, NUM_INPUT, &(*rec)[num]);
+        if (err != DDCA_OK)
         {
-            ags[ag].t[ags[ag].timeNum] = time;
-            ags[ag].timeNum++;
-            if (ags[ag].timeNum == 200)
-                ags[ag].timeNum = 0;
+            if (err == DDCA_ERR_ANTIGEN)
+                fprintf(stderr, "wrong antigen input\n");
+            else if (err == DDCA_ERR_SIGNAL)
+                fprintf(stderr, "wrong signal input\n");
+            else
+                fprintf(stderr, "wrong input\n");
+            getchar();
+            exit(EXIT_FAILURE);
         }
+        num++;
     }
-    if (!ags[ag].timeNum)
-    {
-        ags[ag].t[0] = time;
-        ags[ag].timeNum = 1;
-    }
+    return num;
 }
 
 /*
- *  dc - DC structure; ags - antigen profile
- *  A function that updates the global antigen profile by a given DC
+ *  config - engine parameters; recs, numRecs - decoded data streams;
+ *  ensMcav, ensVar, ensK - MCAV mean and variance and K mean per antigen;
+ *  A function that runs ENSEMBLE randomly seeded engines concurrently over the same
+ *  decoded data streams and aggregates their MCAV per antigen
  */
-static void log_antigen(struct DC *dc, struct agtype *ags)
+static void ensemble(const struct ddca_config *config, struct ddca_record **recs, const int *numRecs,
+                     double *ensMcav, double *ensVar, double *ensK)
 {
-    int q;
-    int yy;
-
-    for(q =0; q< 99999; q++)
-    {
-        if(dc->antigen[q])
-        {
-            dc->totAg +=dc->antigen[q];
-            for(yy= 0; yy < dc->antigen[q]; yy++)
-            {
-                ags[q].k = ags[q].k + dc->k;
-                if(dc->k > 0)
-                {
-                    ags[q].m = ags[q].m + 1;    // update m if mature cell (danger)
-                }
-                else
-                {
-                    ags[q].s = ags[q].s + 1;    // update s if semi-mature cell (safe)
-                }
-            }
-            dc->antigen[q] = 0;
+    ddca_engine *eng[ENSEMBLE];
+    const struct ddca_antigen *profile;
+    int e,i,n;
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for(e=0; e< ENSEMBLE; e++)
+    {
+        struct ddca_config c = *config;
+        int s;
+        c.randomised = 1;
+        c.seed = (unsigned long) ENSEMBLE_SEED + e;
+        c.profileOnly = 1;  // only the MCAV and K values are aggregated
+        eng[e] = ddca_create(&c);
+        if (eng[e] == NULL)
+            continue;
+        for(s=0; s< c.numStreams; s++)
+        {   // each stream has its own population, flush it before the next one
+            ddca_push(eng[e], s, recs[s], numRecs[s]);
+            ddca_end_stream(eng[e], s);
         }
+        ddca_poll(eng[e]);
     }
-    //printf("DC_id: %d, totAg: %d , iter: %d \n", dc->id, dc->totAg, dc->iter);
-}
-
-/*
- *  K - K value; csm - CSM value; dc - DC structure; currJ - current cell index; ags - antigen profile;
- *  *cell - DC population;
- *  A function that updates the DC based on the signal's K and CSM values
- */
-static void update_DC(float K, float csm, struct DC *dc, int currJ, struct agtype *ags, struct DC *cell)
-{
-    int tr_interval;
-    /* update DC output signals */
-    dc->lifespan -= csm;
-    dc->k += K;
-    dc->iter++;
-
-    if (dc->lifespan <= 0)  // cell reincarnation if lifespan has reached zero
-    {
-        log_antigen(dc, ags);
-        tr_interval = (float) MAX_MIG / (numCells - 1);
-        dc->lifespan = ((dc) - cell) * tr_interval;
-        dc->k = 0;
-        dc->totIter += dc->iter;
-        //printf("running totIter %d", dc->totIter);
-        //printf("reset DC lifespan is %f \n", dc->lifespan);
-        //printf("iterations of cell[%d]: %d \n", currJ, dc->iter);
-        dc->iter = 0;
-        dc->totAg = 0;
-        dc->incarnations++;
-    }
-    /* pass antigen to the global antigen profile */
-
-}
-
-/*
- *  sig1 and sig2 - danger and safe signals; cell - DC population; num_cells - number of cells;
- *  ags - antigen profile;
- *  A function that processes the incoming signals and passes this information for the DC update
- */
-static void do_signals(float sig1, float sig2, struct DC *cell, int num_cells, struct agtype *ags)
-{
-    float csm;
-    float k;
-    int j;
-
-    csm = sig1 + sig2;
-    k = (sig1 - sig2) - sig2;
-    //printf("signal: csm=%f k=%f\n", csm, k);
-
-    for(j=0; j< num_cells; j++)
+    for(e=0; e< ENSEMBLE; e++)
     {
-        update_DC(k, csm, &cell[j], j, ags, cell);
-    }
-
-}
-
-/*
- *  *buf - input buffer; *cell - DC population; *cell_index - population's cell index;
- *  *ags - antigen profile;
- *  A function that processes data stream lines and calls the functions for antigen and
- *  signal processing
- */
-static void input_line(char *buf, struct DC *cell, int *cell_index, struct agtype *ags)
-{
-    char *tok[4];
-    int n,p;
-    int index;
-    pid_t ag;
-    double time;
-    float sig1, sig2;
-    char *sp = " "; // this is the separation between attributes
-    index = *cell_index;
-
-    n = easy_explode(buf, *sp, tok, 4);
-
-    switch ( n )
-    {
-    case 3:		/*this is antigen that has 3 fields*/
-        if (strcmp(tok[1], "antigen"))
+        if (eng[e] == NULL)
         {
-            fprintf(stderr, "wrong antigen input\n");
-            getchar();
+            fprintf(stderr, "Error in ensemble initialisation\n");
             exit(EXIT_FAILURE);
         }
-        ag = atoi(tok[2]);  // antigen ID
-        time = strtod(tok[0], NULL);    // timestamp
-        index++;
-        index %= numCells;
-        do_antigen(ag, &cell[index], time, ags);
-        *cell_index = index;
-
-        break;
-    case 4:		/*this is for signals that have 4 fields */
-        if(strcmp(tok[1], "signal"))
-        {
-            fprintf(stderr, "wrong signal input\n");
-            getchar();
-            exit(EXIT_FAILURE);
-        }
-        sig1 = atof(tok[2]);    // danger signal
-        sig2 = atof(tok[3]);    // safe signal
-
-        do_signals(sig1, sig2, cell, numCells, ags);
-        break;
-    default:
-        fprintf(stderr, "wrong input\n");
-        getchar();
-        exit(EXIT_FAILURE);
     }
-}
 
-/*
- * *ags - antigen profile;
- *  A function that calculates the MCAV and K values of the antigens
- *  in the global profile and updates the 'dangerous' antigen profile
- */
-static void result(struct agtype *ags)
-{
-    int i,p;
-    float mcav,ka;
-    for(i=0; i<99999; i++)
+    for(e=0; e< ENSEMBLE; e++)
     {
-        if((ags[i].m + ags[i].s) != 0)
+        profile = ddca_profile(eng[e], &n);
+        for(i=0; i< n; i++)
         {
-            mcav = ags[i].m/(ags[i].m + ags[i].s);
-            ka = ags[i].k/(ags[i].m + ags[i].s);
-            printf("AgType %d %f %f\n", i, mcav, ka);
-            if (mcav > 0)
-            {
-                agsD[ags_index] = ags[i];
-                agsD[ags_index].id = i;
-                agsD[ags_index].mcav = mcav;
-                agsD[ags_index].k = ka;
-                agsD[ags_index].ant_index = 0;
-                ags_index++;
-            }
+            ensMcav[profile[i].id] += profile[i].mcav;
+            ensVar[profile[i].id] += (double) profile[i].mcav * profile[i].mcav;
+            ensK[profile[i].id] += profile[i].k;
         }
+        ddca_destroy(eng[e]);
     }
-}
-
-/*
- *  id - antigen ID;
- *  A function that checks if the given antigen has already been
- *  recorded  in any of the cooccurrences
- */
-static int checkCooccurrence(int id)
-{
-    int k,l;
-    for(k=0; k<=tempIndex1; k++)
+    for(i=0; i<99999; i++)
     {
-        l = 0;
-        while(cooccurrenceTemp[k][l])
-        {
-            if(id == cooccurrenceTemp[k][l])
-                return k;
-            l++;
-        }
+        ensMcav[i] /= ENSEMBLE;
+        ensVar[i] = ensVar[i] / ENSEMBLE - ensMcav[i] * ensMcav[i];
+        if (ensVar[i] < 0)
+            ensVar[i] = 0;
+        ensK[i] /= ENSEMBLE;
     }
-    return -1;
 }
 
 /*
- *  id - antigen ID; dId - antigen ID;
- *  A function that returns the ID for the cooccurrence recording
- *  in the antigen's local 2D array
+ *  file - output stream; ensMcav, ensVar, ensK - ensemble profile;
+ *  A function that prints the ensemble profile of the antigens with a non-zero MCAV
  */
-static int checkAntigen(int id, int dId)
+static void ensembleOutput(FILE *file, const double *ensMcav, const double *ensVar, const double *ensK)
 {
-    int j;
-    for(j=0; j< 20; j++)
+    int i;
+    fprintf(file, "\nEnsemble profile (%d populations, seed %d):\n", ENSEMBLE, ENSEMBLE_SEED);
+    for(i=0; i<99999; i++)
     {
-        if(id == agsD[dId].antigens[j][0])
-            return j;
+        if (ensMcav[i] > 0)
+            fprintf(file, "id %d, mcav mean %f, mcav var %g, k mean %f\n", i, ensMcav[i], ensVar[i], ensK[i]);
     }
-    return -1;
 }
 
 /*
- *  Dual Cooccurrence function
- *  A function that compares the timestamps of dangerous antigens and records the matches
+ *  file - output stream; e - engine;
+ *  A function that prints the Dual Cooccurrences
  */
-static void cooccurrence()
+static void pairsOutput(FILE *file, const ddca_engine *e)
 {
-    int q,p,i,k,j;
-    int aId;
-    for(q =0; q < (ags_index-1); q++)
+    const struct ddca_pair *pairs;
+    int i,n;
+    pairs = ddca_pairs(e, &n);
+    for(i=0; i< n; i++)
     {
-        memset(agsD[q].antigens, 0, sizeof(agsD[q].antigens[0][0]) * 20 * 2);
-        for(i = (q+1); i < ags_index; i++)
-        {
-            for(p=0; p< 200; p++)
-            {
-                for(k=0; k<200; k++)
-                {   // check that the antigens are within the same time window
-                    if (agsD[q].t[p] && agsD[i].t[k] && fabs(agsD[q].t[p] - agsD[i].t[k]) <= timeWinCo)
-                    {
-                        aId = checkAntigen(agsD[i].id, q);
-                        if (aId != -1)  // increment the number of matches
-                            agsD[q].antigens[aId][1] = agsD[q].antigens[aId][1] + 1;
-                        else
-                        {   // add a new entry if has not been previously recorded
-                            agsD[q].antigens[agsD[q].ant_index][0] = agsD[i].id;
-                            agsD[q].antigens[agsD[q].ant_index][1] = agsD[q].antigens[agsD[q].ant_index][1] + 1;
-                            agsD[q].ant_index = agsD[q].ant_index + 1;
-                        }
-                    }
-                }
-            }
-        }
-    }
-    printf("\nDual Cooccurrence:\n"); // print the Dual cooccurrences
-    for(j=0; j<100; j++)
-    {
-        if(agsD[j].id)
-        {
-            for (i=0; i<20; i++)
-            {
-                if (agsD[j].antigens[i][1] != 0)
-                    printf("%d - %d (%d times)\n", agsD[j].id, agsD[j].antigens[i][0], agsD[j].antigens[i][1]);
-            }
-        }
+        fprintf(file, "%d - %d (%d times)\n", pairs[i].id1, pairs[i].id2, pairs[i].num);
     }
 }
 
 /*
- *  Multiple Cooccurrence Function
- *  A function that groups the interconnected antigens into a string
+ *  file - output stream; e - engine;
+ *  A function that prints the Multiple Cooccurrences
  */
-static void multiCooccurrence()
+static void groupsOutput(FILE *file, const ddca_engine *e)
 {
-    int i,j,l;
-    printf("\nMultiple Cooccurrence:\n");
-    tempIndex1 = 0;
-    for(j=0; j<100; j++)
+    const int *group;
+    int k,l,n;
+    for(k=0; k< ddca_num_groups(e); k++)
     {
-        if(agsD[j].id)
+        group = ddca_group(e, k, &n);
+        for(l=0; l< n; l++)
         {
-            tempIndex2 = 0;
-            for (i=0; i<20; i++)
-            {
-                if (agsD[j].antigens[i][1] != 0 && checkCooccurrence(agsD[j].antigens[i][0]) == -1)
-                {
-                    if (checkCooccurrence(agsD[j].id) == -1)
-                    {
-                        cooccurrenceTemp[tempIndex1][tempIndex2] = agsD[j].id;
-                        tempIndex2++;   // add the first element of the string
-                    }
-                    cooccurrenceTemp[tempIndex1][tempIndex2] = agsD[j].antigens[i][0];
-                    tempIndex2++;   // add the cooccurred elements and increment the index
-                    cooccurrenceRec(agsD[j].antigens[i][0]); // start the recursive method with the added antigens
-                }
-            }
-            for (l=0; l<tempIndex2 && tempIndex2 > 2; l++)  // print the results
-            {
-                printf("%d ", cooccurrenceTemp[tempIndex1][l]);
-            }
-            if (tempIndex2 > 2)
-            {
-                printf("\n\n");
-                tempIndex1++;
-            }
-        }
-    }
-}
-
-/*
- *  A recursive function that supplements the Multiple Cooccurrence function
- */
-void cooccurrenceRec(int aId)
-{
-    int i,j;
-    for (i=0; i<100; i++) {
-        if (agsD[i].id) {
-            for (j=0; j<20; j++)
-            {   // check if any other antigens have a cooccurrence with this ID
-                if (agsD[i].antigens[j][0] == aId && agsD[i].antigens[j][1] != 0 && checkCooccurrence(agsD[i].id) == -1)
-                {
-                    cooccurrenceTemp[tempIndex1][tempIndex2] = agsD[i].id;
-                    tempIndex2++;
-                }
-            }
-        }
-        if (agsD[i].id == aId)
-        {
-            for (j=0; j<20; j++)
-            {   // check if this antigen ID has any other cooccurrences
-                if (agsD[i].antigens[j][1] != 0 && checkCooccurrence(agsD[i].antigens[j][0]) == -1)
-                {
-                    cooccurrenceTemp[tempIndex1][tempIndex2] = agsD[i].antigens[j][0];
-                    tempIndex2++;
-                    cooccurrenceRec(agsD[i].antigens[j][0]); // apply the same function on new cooccurrences
-                }
-            }
+            fprintf(file, "%d ", group[l]);
         }
+        fprintf(file, "\n\n");
     }
 }
 
@@ -508,44 +233,28 @@ void cooccurrenceRec(int aId)
  * A function that saves the results in a file called "output.txt"
  *
  */
-void printOutput()
+void printOutput(const ddca_engine *e, const double *ensMcav, const double *ensVar, const double *ensK)
 {
+    const struct ddca_antigen *agsD;
     time_t t;
     time(&t);
-    int q,j,i,k,l;
+    int q,n;
     FILE *file;
     file = fopen("output.txt","a+");    // name of the file
     fprintf(file, "\n\n%sAntigen profile:\n", ctime(&t));   // primary Antigen Profile
-    for(q =0; q < ags_index; q++)
+    agsD = ddca_dangerous(e, &n);
+    for(q =0; q < n; q++)
     {
         fprintf(file, "id %d, mcav %f, k %f\n", agsD[q].id, agsD[q].mcav, agsD[q].k);
     }
-    fprintf(file, "\nDual Cooccurrence:\n");  // Dual Cooccurrence Analysis
-    for(j=0; j<100; j++)
+    if (ENSEMBLE > 1)
     {
-        if(agsD[j].id)
-        {
-            for (i=0; i<20; i++)
-            {
-                if (agsD[j].antigens[i][1] != 0)
-                    fprintf(file, "%d - %d (%d times)\n", agsD[j].id, agsD[j].antigens[i][0], agsD[j].antigens[i][1]);
-            }
-        }
+        ensembleOutput(file, ensMcav, ensVar, ensK);   // Ensemble Antigen Profile
     }
+    fprintf(file, "\nDual Cooccurrence:\n");  // Dual Cooccurrence Analysis
+    pairsOutput(file, e);
     fprintf(file, "\nMultiple Cooccurrence:\n");  // Multiple Cooccurrence Analysis
-    for(k=0; k<=tempIndex1; k++)
-    {
-        l = 0;
-        if (cooccurrenceTemp[k][2])
-        {
-            while(cooccurrenceTemp[k][l])
-            {
-                fprintf(file, "%d ", cooccurrenceTemp[k][l]);
-                l++;
-            }
-            fprintf(file, "\n\n");
-        }
-    }
+    groupsOutput(file, e);
     fclose(file);
 }
 
@@ -568,6 +277,8 @@ const char * getText()
 int main(int argc, char **argv)
 {
     int numberStr;  // number of Streams
+    unsigned int numCells;   /*DC population size */
+    float maxMig;    /*migration threshold */
     int verification = -1;
     time_t t;
     time(&t);
@@ -634,134 +345,163 @@ int main(int argc, char **argv)
         filename4 = getText();
         file4 = fopen ( filename4, "r" );
     }
-    char buf[256];
     int i;
     int p;	/*some counters */
-    int q;
-    cell_index1 = 0; /* for the selection of DCs per antigen */
-    cell_index2 = 0; /* for the selection of DCs per antigen */
-    cell_index3 = 0; /* for the selection of DCs per antigen */
-    cell_index4 = 0; /* for the selection of DCs per antigen */
-    ags_index = 0;
-    timeWinSave = (double) TIME_WIN_SAVE;
-    timeWinCo = (double) TIME_WIN_CO;
-    cell1= calloc(numCells, sizeof(struct DC));
-    cell2= calloc(numCells, sizeof(struct DC));
-    cell3= calloc(numCells, sizeof(struct DC));
-    cell4= calloc(numCells, sizeof(struct DC));
-
-    if(cell1==NULL && cell2==NULL && cell3==NULL && cell4==NULL)
-    {
-        printf("Error in cell initialisation\n");
-        return EXIT_FAILURE;
-    }
-
-    // initialise the DCs in the populations
-    for(i=0; i < numCells; i++)
-    {
-        initDC(&cell1[i], numCells, cell1);
-        initDC(&cell2[i], numCells, cell2);
-        initDC(&cell3[i], numCells, cell3);
-        initDC(&cell4[i], numCells, cell4);
-    }
+    int q,n;
+    struct ddca_record *recs[DDCA_NUM_STREAM] = {NULL};  /*decoded data streams (1-4) */
+    int numRecs[DDCA_NUM_STREAM] = {0};
+    struct ddca_config config;
+    struct ddca_dc_stats stats;
+    const struct ddca_antigen *ags;
+    double *ensMcav = NULL;  /*MCAV mean over the ensemble per antigen */
+    double *ensVar = NULL;   /*MCAV variance over the ensemble per antigen */
+    double *ensK = NULL;     /*K mean over the ensemble per antigen */
+    ddca_engine *engine;
+    unsigned long lostAg, lostTime;
 
     // read the data logs
     if (numberStr >= 1) {
-    while (fgets (buf, sizeof(buf), file1) != NULL ) /* read a line */
-    {
-        char *tmp;
-        tmp = strchr(buf, '\n');
-        if(tmp)
-        {
-            *tmp = 0;
-        }
-        input_line(buf, cell1, &cell_index1, agsG);
-    }
+    numRecs[0] = read_log(file1, &recs[0]);
     fclose(file1);
     }
-
     if (numberStr >= 2) {
-    while (fgets (buf, sizeof(buf), file2) != NULL ) /* read a line */
-    {
-        char *tmp;
-        tmp = strchr(buf, '\n');
-        if(tmp)
-        {
-            *tmp = 0;
-        }
-        input_line(buf, cell2, &cell_index2, agsG);
-    }
+    numRecs[1] = read_log(file2, &recs[1]);
     fclose(file2);
     }
-
     if (numberStr >= 3) {
-    while (fgets (buf, sizeof(buf), file3) != NULL ) /* read a line */
-    {
-        char *tmp;
-        tmp = strchr(buf, '\n');
-        if(tmp)
+    numRecs[2] = read_log(file3, &recs[2]);
+    fclose(file3);
+    }
+    if (numberStr >= 4) {
+    numRecs[3] = read_log(file4, &recs[3]);
+    fclose(file4);
+    }
+
+    config.recordSize = sizeof(struct ddca_record);
+    config.numInput = NUM_INPUT;
+    config.csmWeights = csmWeight;
+    config.kWeights = kWeight;
+    config.numCells = numCells;
+    config.maxMig = maxMig;
+    config.numStreams = DDCA_NUM_STREAM;
+    config.timeWinSave = (double) DDCA_TIME_WIN_SAVE;
+    config.timeWinCo = (double) DDCA_TIME_WIN_CO;
+    config.randomised = 0;
+    config.seed = 0;
+    config.profileOnly = 0;
+    config.hasEpoch = 0;
+    config.epoch = 0;
+    for(i=0; i < numberStr; i++)
+    {   // the earliest timestamp is the epoch of the packed timestamps
+        for(p=0; p < numRecs[i]; p++)
         {
-            *tmp = 0;
+            if (!config.hasEpoch || recs[i][p].time < config.epoch)
+                config.epoch = recs[i][p].time;
+            config.hasEpoch = 1;
         }
-        input_line(buf, cell3, &cell_index3, agsG);
     }
-    fclose(file3);
+    n = ddca_check_config(&config);
+    if (n == DDCA_ERR_EPOCH)
+    {
+        printf("Error: the logs have no finite timestamps for the compact layout\n");
+        return EXIT_FAILURE;
     }
-
-    if (numberStr >= 4) {
-    while (fgets (buf, sizeof(buf), file4) != NULL ) /* read a line */
+    else if (n != DDCA_OK)
     {
-        char *tmp;
-        tmp = strchr(buf, '\n');
-        if(tmp)
+        printf("Error in the engine configuration\n");
+        return EXIT_FAILURE;
+    }
+    engine = ddca_create(&config);
+    if(engine == NULL)
+    {
+        printf("Error in cell initialisation\n");
+        return EXIT_FAILURE;
+    }
+    for(i=0; i < numCells; i++)
+    {
+        for(p=0; p < DDCA_NUM_STREAM; p++)
         {
-            *tmp = 0;
+            ddca_dc_stats(engine, p, i, &stats);
+            printf("lifespan = %f, tm_interval =%f\n", stats.lifespan, maxMig / (numCells-1));
         }
-        input_line(buf, cell4, &cell_index4, agsG);
-    }
-    fclose(file4);
     }
 
-    // update the antigens in the global profile
-    for(p = 0; p < numCells; p++)
+    // process the data streams
+    for(i=0; i < numberStr; i++)
     {
-        //printf("flushed cell ID %d\n", p);
-        log_antigen(&cell1[p], agsG);
-        log_antigen(&cell2[p], agsG);
-        log_antigen(&cell3[p], agsG);
-        log_antigen(&cell4[p], agsG);
+        ddca_push(engine, i, recs[i], numRecs[i]);
     }
 
+    // update the antigens in the global profile
+    ddca_flush(engine);
+    ddca_overflow(engine, &lostAg, &lostTime);
+    if (lostAg || lostTime)
+        fprintf(stderr, "Warning: %lu antigens and %lu timestamps did not fit the compact layout\n", lostAg, lostTime);
+
     // print the DC statistics
     for(q =0; q <numCells; q++)
     {
-        dc_stats(&cell1[q]);
-        dc_stats(&cell2[q]);
-        dc_stats(&cell3[q]);
-        dc_stats(&cell4[q]);
+        for(p=0; p < DDCA_NUM_STREAM; p++)
+        {
+            ddca_dc_stats(engine, p, q, &stats);
+            dc_stats(&stats);
+        }
     }
-    free((void*) cell1);
-    free((void*) cell2);
-    free((void*) cell3);
-    free((void*) cell4);
 
-    result(agsG);
+    if (ddca_poll(engine) > DDCA_MAX_DANGER)
+        fprintf(stderr, "Warning: only the first %d dangerous antigens are analysed\n", DDCA_MAX_DANGER);
+    if (ddca_saturated(engine))
+        fprintf(stderr, "Warning: the cooccurrence sketches of %d antigens are more than a quarter full, increase SKETCH_BITS\n", ddca_saturated(engine));
+    ags = ddca_profile(engine, &n);
+    for(i=0; i < n; i++)
+    {
+        printf("AgType %d %f %f\n", ags[i].id, ags[i].mcav, ags[i].k);
+    }
+    if (ENSEMBLE > 1)
+    {
+        ensMcav = calloc(99999, sizeof(double));
+        ensVar = calloc(99999, sizeof(double));
+        ensK = calloc(99999, sizeof(double));
+        if (ensMcav == NULL || ensVar == NULL || ensK == NULL)
+        {
+            fprintf(stderr, "Error in ensemble initialisation\n");
+            return EXIT_FAILURE;
+        }
+        config.numStreams = numberStr;
+        ensemble(&config, recs, numRecs, ensMcav, ensVar, ensK); // randomly seeded populations over the same data streams
+    }
+    for(i=0; i < numberStr; i++)
+    {
+        free((void*) recs[i]);
+    }
 
     printf("process is finished...\n\n");
+    if (ENSEMBLE > 1)
+    {
+        ensembleOutput(stdout, ensMcav, ensVar, ensK);
+        printf("\n");
+    }
 
     printf("%sAntigen profile:\n", ctime(&t));  // print out the dangerous antigens' profiles
-    if(ags_index == 0) {
+    ags = ddca_dangerous(engine, &n);
+    if(n == 0) {
         printf("No dangerous antigens found\n");
         getchar();
         return EXIT_SUCCESS;
     }
-    for(q =0; q < ags_index; q++)
+    for(q =0; q < n; q++)
     {
-        printf("id %d, mcav %f, k %f\n", agsD[q].id, agsD[q].mcav, agsD[q].k);
+        printf("id %d, mcav %f, k %f\n", ags[q].id, ags[q].mcav, ags[q].k);
     }
-    cooccurrence();  // Dual Cooccurrence
-    multiCooccurrence(); // Multiple Cooccurrence
-    printOutput();  // save the output in a file
+    printf("\nDual Cooccurrence:\n"); // print the Dual cooccurrences
+    pairsOutput(stdout, engine);
+    printf("\nMultiple Cooccurrence:\n");
+    groupsOutput(stdout, engine);
+    printOutput(engine, ensMcav, ensVar, ensK);  // save the output in a file
+    ddca_destroy(engine);
+    free((void*) ensMcav);
+    free((void*) ensVar);
+    free((void*) ensK);
     getchar();
     return EXIT_SUCCESS;
 }